@@ -0,0 +1,212 @@
+// Host benchmark comparing PacketFull, PacketHalf and the YCoCg packets.
+// Reports bytes per frame, PSNR against the source frame and the decode cost.
+//
+// Build and run from the repository root:
+// g++ -O2 -std=c++17 -Isrc bench/ycocg_bench.cpp -o ycocg_bench && ./ycocg_bench
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_RDTSC 1
+#endif
+
+#include "packet.hpp"
+#include "ycocg.hpp"
+
+constexpr uint32_t FRAME_SIZE = 16u * 16u * 3u;
+constexpr uint32_t DECODE_ITERATIONS = 200000u;
+
+typedef void (*FillFn)(uint8_t *rgb);
+
+// Test frames
+
+static void fill_gradient(uint8_t *rgb) {
+    for(uint32_t i{}; i < 16u * 16u; ++i) {
+        uint32_t x = i % 16u, y = i / 16u;
+
+        rgb[i * 3u + 0u] = (uint8_t)(x * 17u);
+        rgb[i * 3u + 1u] = (uint8_t)(y * 17u);
+        rgb[i * 3u + 2u] = (uint8_t)(255u - (x + y) * 8u);
+    }
+}
+
+static void fill_dark_gradient(uint8_t *rgb) {
+    // Dim smooth ramp, the worst case for 4bpp banding
+    for(uint32_t i{}; i < 16u * 16u; ++i) {
+        uint32_t x = i % 16u, y = i / 16u;
+
+        rgb[i * 3u + 0u] = (uint8_t)(x * 2u + y);
+        rgb[i * 3u + 1u] = (uint8_t)(x + 8u);
+        rgb[i * 3u + 2u] = (uint8_t)(y * 3u);
+    }
+}
+
+static void fill_radial(uint8_t *rgb) {
+    for(uint32_t i{}; i < 16u * 16u; ++i) {
+        float dx = (float)(i % 16u) - 7.5f, dy = (float)(i / 16u) - 7.5f;
+        float d = std::sqrt(dx * dx + dy * dy) / 10.61f;
+
+        rgb[i * 3u + 0u] = (uint8_t)(255.0f * (1.0f - d));
+        rgb[i * 3u + 1u] = (uint8_t)(180.0f * d);
+        rgb[i * 3u + 2u] = (uint8_t)(128.0f + 127.0f * std::sin(d * 6.28f));
+    }
+}
+
+static void fill_hard_edges(uint8_t *rgb) {
+    // Saturated single-pixel colour changes, the worst case for chroma subsampling
+    static const uint8_t palette[4][3] = { {255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 255} };
+
+    for(uint32_t i{}; i < 16u * 16u; ++i) {
+        const uint8_t *c = palette[((i % 16u) + (i / 16u)) % 4u];
+
+        memcpy(&rgb[i * 3u], c, 3u);
+    }
+}
+
+static void fill_noise(uint8_t *rgb) {
+    uint32_t state = 0x12345678u;
+
+    for(uint32_t i{}; i < FRAME_SIZE; ++i) {
+        state = state * 1664525u + 1013904223u;
+        rgb[i] = (uint8_t)(state >> 24);
+    }
+}
+
+// Encoders and decoders (decoders mirror on_buffer_ready in main.cpp)
+
+static void encode_full(const uint8_t *rgb, PacketFull &p) {
+    memcpy(p.data, rgb, FRAME_SIZE);
+}
+
+static void decode_full(const PacketFull &p, uint8_t *rgb) {
+    for(uint32_t i{}; i < 16u * 16u; ++i) {
+        rgb[i * 3u + 0u] = p.data[i * 3u + 0u];
+        rgb[i * 3u + 1u] = p.data[i * 3u + 1u];
+        rgb[i * 3u + 2u] = p.data[i * 3u + 2u];
+    }
+}
+
+static void encode_half(const uint8_t *rgb, PacketHalf &p) {
+    for(uint32_t i{}; i < FRAME_SIZE / 2u; ++i) {
+        p.data[i] = (uint8_t)((rgb[i * 2u] & 0xf0) | (rgb[i * 2u + 1u] >> 4));
+    }
+}
+
+static void decode_half(const PacketHalf &p, uint8_t *rgb) {
+    for(uint32_t idx{}; idx < 16u * 16u; ++idx) {
+        uint8_t r = (idx % 2u == 0u) ? ((p.data[idx * 3u / 2u + 0u] & 0xf0) >> 4) :  (p.data[idx * 3u / 2u + 0u] & 0x0f);
+        uint8_t g = (idx % 2u == 0u) ?  (p.data[idx * 3u / 2u + 0u] & 0x0f)       : ((p.data[idx * 3u / 2u + 1u] & 0xf0) >> 4);
+        uint8_t b = (idx % 2u == 0u) ? ((p.data[idx * 3u / 2u + 1u] & 0xf0) >> 4) :  (p.data[idx * 3u / 2u + 1u] & 0x0f);
+
+        rgb[idx * 3u + 0u] = r << 4;
+        rgb[idx * 3u + 1u] = g << 4;
+        rgb[idx * 3u + 2u] = b << 4;
+    }
+}
+
+static void encode_ycocg(const uint8_t *rgb, PacketYCoCg &p) {
+    ycocg_encode_8bit(rgb, p.luma, p.co, p.cg);
+}
+
+static void decode_ycocg(const PacketYCoCg &p, uint8_t *rgb) {
+    ycocg_decode(p.luma, p.co, p.cg, rgb);
+}
+
+static void encode_ycocg_quant(const uint8_t *rgb, PacketYCoCgQuant &p) {
+    ycocg_encode_quant(rgb, p.luma, p.chroma);
+}
+
+static void decode_ycocg_quant(const PacketYCoCgQuant &p, uint8_t *rgb) {
+    ycocg_decode_quant(p.luma, p.chroma, rgb);
+}
+
+// Measurement
+
+static double psnr(const uint8_t *a, const uint8_t *b) {
+    double mse{};
+
+    for(uint32_t i{}; i < FRAME_SIZE; ++i) {
+        double d = (double)a[i] - (double)b[i];
+        mse += d * d;
+    }
+
+    mse /= (double)FRAME_SIZE;
+
+    return (mse == 0.0) ? INFINITY : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+struct DecodeCost {
+    double ns;
+    double cycles; // 0 when the cycle counter is unavailable
+};
+
+template<typename Packet>
+static DecodeCost measure_decode(const Packet &p, void (*decode)(const Packet&, uint8_t*)) {
+    static uint8_t rgb[FRAME_SIZE];
+    volatile uint8_t sink{};
+
+#ifdef BENCH_HAS_RDTSC
+    uint64_t c0 = __rdtsc();
+#endif
+    auto t0 = std::chrono::steady_clock::now();
+
+    for(uint32_t i{}; i < DECODE_ITERATIONS; ++i) {
+        decode(p, rgb);
+        sink = sink + rgb[i % FRAME_SIZE];
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+#ifdef BENCH_HAS_RDTSC
+    uint64_t c1 = __rdtsc();
+    double cycles = (double)(c1 - c0) / DECODE_ITERATIONS;
+#else
+    double cycles = 0.0;
+#endif
+
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / DECODE_ITERATIONS;
+
+    return DecodeCost{ ns, cycles };
+}
+
+template<typename Packet>
+static void run(const char *name, const uint8_t *src, void (*encode)(const uint8_t*, Packet&), void (*decode)(const Packet&, uint8_t*)) {
+    Packet p{};
+    uint8_t rgb[FRAME_SIZE];
+
+    encode(src, p);
+    decode(p, rgb);
+
+    DecodeCost cost = measure_decode(p, decode);
+
+    printf("  %-12s %6zu B %8.2f dB %10.1f ns %10.1f cycles\n", name, sizeof(Packet), psnr(src, rgb), cost.ns, cost.cycles);
+}
+
+int main() {
+    struct { const char *name; FillFn fill; } frames[] = {
+        { "gradient",      fill_gradient      },
+        { "dark gradient", fill_dark_gradient },
+        { "radial",        fill_radial        },
+        { "hard edges",    fill_hard_edges    },
+        { "noise",         fill_noise         },
+    };
+
+    printf("Decode cost averaged over %u iterations per packet (host CPU, not the RP2040)\n", DECODE_ITERATIONS);
+#ifndef BENCH_HAS_RDTSC
+    printf("Cycle counter unavailable on this host, cycles are reported as 0\n");
+#endif
+
+    for(const auto &f : frames) {
+        uint8_t src[FRAME_SIZE];
+        f.fill(src);
+
+        printf("%s:\n", f.name);
+        run<PacketFull>("Full", src, encode_full, decode_full);
+        run<PacketHalf>("Half", src, encode_half, decode_half);
+        run<PacketYCoCg>("YCoCg", src, encode_ycocg, decode_ycocg);
+        run<PacketYCoCgQuant>("YCoCgQuant", src, encode_ycocg_quant, decode_ycocg_quant);
+    }
+}
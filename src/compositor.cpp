@@ -0,0 +1,118 @@
+#include "compositor.hpp"
+
+void Compositor::set_layer_config(uint8_t layer_id, uint8_t z_order, uint8_t opacity, LayerRect mask) {
+    Layer &layer = layers[layer_id];
+
+    // Clip the mask to the display, an empty mask covers the whole display
+    if(mask.x >= 16u || mask.y >= 16u || mask.w == 0u || mask.h == 0u) {
+        mask = LayerRect{};
+    } else {
+        if(mask.w > 16u - mask.x) mask.w = 16u - mask.x;
+        if(mask.h > 16u - mask.y) mask.h = 16u - mask.y;
+    }
+
+    if(layer.has_content) {
+        mark_dirty(layer.mask);
+        mark_dirty(mask);
+    }
+
+    layer.z_order = z_order;
+    layer.opacity = opacity;
+    layer.mask = mask;
+}
+
+void Compositor::set_layer_pixels(uint8_t layer_id, const uint8_t *rgb) {
+    Layer &layer = layers[layer_id];
+
+    for(uint32_t i{}; i < 16u*16u*3u; ++i) {
+        layer.rgb[i] = rgb[i];
+    }
+
+    layer.has_content = true;
+
+    mark_dirty(layer.mask);
+}
+
+bool Compositor::compose(WS2812B &led_matrix) {
+    if(!is_dirty) {
+        return false;
+    }
+
+    if(is_first_compose) {
+        dirty_rect = LayerRect{};
+        is_first_compose = false;
+    }
+
+    // Visible layers touching the dirty area, sorted by z_order (insertion sort, there are only a few of them)
+    const Layer *order[COMPOSITOR_MAX_LAYERS]{};
+    uint32_t order_count{};
+
+    for(uint32_t i{}; i < COMPOSITOR_MAX_LAYERS; ++i) {
+        const Layer &layer = layers[i];
+        if(!layer.has_content || layer.opacity == 0u) {
+            continue;
+        }
+
+        if(layer.mask.x >= dirty_rect.x + dirty_rect.w || dirty_rect.x >= layer.mask.x + layer.mask.w ||
+           layer.mask.y >= dirty_rect.y + dirty_rect.h || dirty_rect.y >= layer.mask.y + layer.mask.h) {
+            continue;
+        }
+
+        uint32_t j = order_count++;
+        while(j > 0u && order[j - 1u]->z_order > layer.z_order) {
+            order[j] = order[j - 1u];
+            --j;
+        }
+
+        order[j] = &layer;
+    }
+
+    for(uint32_t y = dirty_rect.y; y < (uint32_t)dirty_rect.y + dirty_rect.h; ++y) {
+        for(uint32_t x = dirty_rect.x; x < (uint32_t)dirty_rect.x + dirty_rect.w; ++x) {
+            uint32_t idx = y * 16u + x;
+
+            // Start from black and blend every layer on top
+            uint32_t rgb[3]{};
+
+            for(uint32_t i{}; i < order_count; ++i) {
+                const Layer &layer = *order[i];
+
+                if(x < layer.mask.x || x >= (uint32_t)layer.mask.x + layer.mask.w ||
+                   y < layer.mask.y || y >= (uint32_t)layer.mask.y + layer.mask.h) {
+                    continue;
+                }
+
+                uint32_t a = layer.opacity;
+
+                for(uint32_t c{}; c < 3u; ++c) {
+                    rgb[c] = (layer.rgb[idx * 3u + c] * a + rgb[c] * (255u - a) + 127u) / 255u;
+                }
+            }
+
+            led_matrix.set_pixel(x, y, rgb[0], rgb[1], rgb[2]);
+        }
+    }
+
+    led_matrix.update_display();
+
+    is_dirty = false;
+
+    return true;
+}
+
+void Compositor::mark_dirty(LayerRect rect) {
+    if(!is_dirty) {
+        dirty_rect = rect;
+        is_dirty = true;
+
+        return;
+    }
+
+    // Grow the dirty area to the bounding box of both rectangles
+    uint32_t x0 = (rect.x < dirty_rect.x) ? rect.x : dirty_rect.x;
+    uint32_t y0 = (rect.y < dirty_rect.y) ? rect.y : dirty_rect.y;
+    uint32_t x1 = ((uint32_t)rect.x + rect.w > (uint32_t)dirty_rect.x + dirty_rect.w) ? (uint32_t)rect.x + rect.w : (uint32_t)dirty_rect.x + dirty_rect.w;
+    uint32_t y1 = ((uint32_t)rect.y + rect.h > (uint32_t)dirty_rect.y + dirty_rect.h) ? (uint32_t)rect.y + rect.h : (uint32_t)dirty_rect.y + dirty_rect.h;
+
+    dirty_rect = LayerRect{ (uint8_t)x0, (uint8_t)y0, (uint8_t)(x1 - x0), (uint8_t)(y1 - y0) };
+}
@@ -0,0 +1,49 @@
+#ifndef _COMPOSITOR_HPP
+#define _COMPOSITOR_HPP
+
+#include <cstdint>
+
+#include "ws2812b.hpp"
+
+constexpr uint8_t COMPOSITOR_MAX_LAYERS = 8u;
+
+// Rectangle in the same coordinates as set_pixel(), (x:0, y:0) being the lower-left corner.
+struct LayerRect {
+    uint8_t x{}, y{}, w{16u}, h{16u};
+};
+
+// Blends per-client layers into a single frame.
+// Only the area covered by layers that changed since the last compose() is blended again.
+class Compositor {
+public:
+    // Layers are drawn from the lowest to the highest z_order, ties are drawn in layer_id order.
+    // Pixels outside of the mask are transparent, an empty mask covers the whole display.
+    void set_layer_config(uint8_t layer_id, uint8_t z_order, uint8_t opacity, LayerRect mask);
+
+    // Replaces the layer's pixels with a frame of row-major 8bpp RGB data.
+    void set_layer_pixels(uint8_t layer_id, const uint8_t *rgb);
+
+    // Blends the changed area and updates the display. Returns false if nothing has changed.
+    bool compose(WS2812B &led_matrix);
+
+private:
+    struct Layer {
+        uint8_t rgb[16u*16u*3u]{};
+        LayerRect mask{};
+        uint8_t z_order{};
+        uint8_t opacity{255u};
+        bool has_content{};
+    };
+
+    Layer layers[COMPOSITOR_MAX_LAYERS]{};
+
+    LayerRect dirty_rect{};
+    bool is_dirty{};
+
+    // The display shows a status fill until the first layer is drawn, all of it has to be replaced
+    bool is_first_compose{true};
+
+    void mark_dirty(LayerRect rect);
+};
+
+#endif
@@ -10,6 +10,7 @@
 #define MEM_ALIGNMENT               4
 #define MEM_SIZE                    4000
 #define MEMP_NUM_TCP_SEG            32
+#define MEMP_NUM_TCP_PCB            8   // Up to TCP_SERVER_MAX_CLIENTS clients plus closing connections
 #define MEMP_NUM_ARP_QUEUE          10
 #define PBUF_POOL_SIZE              24
 #define LWIP_ARP                    1
@@ -7,7 +7,9 @@
 #include <string.h>
 
 #include "packet.hpp"
+#include "ycocg.hpp"
 #include "ws2812b.hpp"
+#include "compositor.hpp"
 #include "tcp_server.hpp"
 #include "secrets.hpp" // WIFI_SSID "", WIFI_PASS ""
 
@@ -19,14 +21,27 @@ constexpr uint16_t SEVER_PORT = 4242;
 constexpr uint32_t FLASH_TARGET_OFFSET = (768u * 1024u);
 static const uint8_t *flash_read_contents = (const uint8_t*)(XIP_BASE); // Adding the offset here makes read/write more inconsistent.
 
-static repeating_timer_t flash_player_timer{};
 static bool flash_player_running = false;
+static absolute_time_t flash_player_next_frame_time{};
+
+// The flash player draws to the layer of the client that started it.
+// Only that client (or a client that moved to that layer) can interrupt it.
+static uint8_t flash_player_client{};
+static uint8_t flash_player_layer{};
 
 static uint16_t begin_frame_idx_inclusive{}; 
 static uint16_t end_frame_idx_inclusive{}; 
 static uint16_t time_interval_ms{};
 static uint16_t current_frame_id{};
 
+// Compositor layer each client draws to, clients can move to another layer with PacketLayerConfig.
+// Clients that never do share the default layer, just like a single client would.
+constexpr uint8_t DEFAULT_LAYER = 0u;
+static uint8_t client_layers[TCP_SERVER_MAX_CLIENTS]{};
+
+// Scratch frame for packets that have to be decoded into 8bpp RGB first
+static uint8_t decoded_rgb[16u * 16u * 3u];
+
 // Allows for better flash data packing and better flash wear. 
 // Instead of using a whole sector per one frame, use one quarter of a sector per frame.
 // Since one frame is 16*16*3 (768) bytes we only waste 25% of memory this way instead of 81.25%.
@@ -85,78 +100,92 @@ static void write_flash_sector_quarter(uint32_t dst_sector_id, uint32_t dst_quar
     restore_interrupts(interrupts);
 }
 
-static bool flash_player_timer_callback(repeating_timer_t *rt) {
-    WS2812B *led_matrix = (WS2812B*)rt->user_data;
-
-    uint32_t current_frame_offset = (uint32_t)current_frame_id * FLASH_SECTOR_SIZE / 4u;
-
-    for(uint32_t x{}; x < 16u; ++x) {
-        for(uint32_t y{}; y < 16u; ++y) {
-            uint32_t idx = y * 16u + x;
+// Stepped from the main loop so the frames are drawn to the owner's layer and blended with the other layers.
+// The main loop never waits past flash_player_next_frame_time, see main().
+static void flash_player_step(Compositor &compositor) {
+    if(!flash_player_running || absolute_time_diff_us(get_absolute_time(), flash_player_next_frame_time) > 0) {
+        return;
+    }
 
-            led_matrix->set_pixel(x, y, 
-                flash_read_contents[FLASH_TARGET_OFFSET + idx * 3u + 0u + current_frame_offset],
-                flash_read_contents[FLASH_TARGET_OFFSET + idx * 3u + 1u + current_frame_offset],
-                flash_read_contents[FLASH_TARGET_OFFSET + idx * 3u + 2u + current_frame_offset]
-            );
-        }
+    // Time measured between the starts of continous frames, skip ahead if the main loop fell behind by more than a frame
+    flash_player_next_frame_time = delayed_by_ms(flash_player_next_frame_time, time_interval_ms);
+    if(absolute_time_diff_us(get_absolute_time(), flash_player_next_frame_time) < 0) {
+        flash_player_next_frame_time = make_timeout_time_ms(time_interval_ms);
     }
 
-    led_matrix->update_display();
+    uint32_t current_frame_offset = (uint32_t)current_frame_id * FLASH_SECTOR_SIZE / 4u;
+
+    // Frames are stored as 8bpp RGB data, same as PacketFull
+    compositor.set_layer_pixels(flash_player_layer, &flash_read_contents[FLASH_TARGET_OFFSET + current_frame_offset]);
 
     // Wrap back to the beginning
     if((++current_frame_id) > end_frame_idx_inclusive) {
         current_frame_id = begin_frame_idx_inclusive;
     }
-
-    return true;
 }
 
-static void on_buffer_ready(const uint8_t *buf, WS2812B &led_matrix) {
-    // Any incoming data will interrupt the currently playing flash player
-    if(flash_player_running) {
-        cancel_repeating_timer(&flash_player_timer);
+static void on_buffer_ready(const uint8_t *buf, uint8_t client_id, Compositor &compositor) {
+    uint8_t buf_data_type = buf[0];
+    uint8_t layer_id = client_layers[client_id];
+
+    // Any incoming data from the owner will interrupt the currently playing flash player.
+    // Layer config only changes how the layer is blended, so the owner can move it around while it plays.
+    if(flash_player_running && buf_data_type != DATA_TYPE_LAYER_CONFIG && (client_id == flash_player_client || layer_id == flash_player_layer)) {
         flash_player_running = false;
     }
 
-    uint8_t buf_data_type = buf[0];
-
     switch(buf_data_type) {
         case DATA_TYPE_FULL: {
             const PacketFull *p = (const PacketFull*)buf;
 
-            for(uint32_t x{}; x < 16u; ++x) {
-                for(uint32_t y{}; y < 16u; ++y) {
-                    uint32_t idx = y * 16u + x;
+            compositor.set_layer_pixels(layer_id, p->data);
+        }   break;
 
-                    led_matrix.set_pixel(x, y, 
-                        p->data[idx * 3u + 0u],
-                        p->data[idx * 3u + 1u],
-                        p->data[idx * 3u + 2u]
-                    );
-                }
+        case DATA_TYPE_HALF: {
+            const PacketHalf *p = (const PacketHalf*)buf;
+
+            for(uint32_t idx{}; idx < 16u * 16u; ++idx) {
+                uint8_t r = (idx % 2u == 0u) ? ((p->data[idx * 3u / 2u + 0u] & 0xf0) >> 4) :  (p->data[idx * 3u / 2u + 0u] & 0x0f);
+                uint8_t g = (idx % 2u == 0u) ?  (p->data[idx * 3u / 2u + 0u] & 0x0f)       : ((p->data[idx * 3u / 2u + 1u] & 0xf0) >> 4);
+                uint8_t b = (idx % 2u == 0u) ? ((p->data[idx * 3u / 2u + 1u] & 0xf0) >> 4) :  (p->data[idx * 3u / 2u + 1u] & 0x0f);
+
+                // Unpack from 4 bits to 8 bits
+                decoded_rgb[idx * 3u + 0u] = r << 4;
+                decoded_rgb[idx * 3u + 1u] = g << 4;
+                decoded_rgb[idx * 3u + 2u] = b << 4;
             }
 
-            led_matrix.update_display();
+            compositor.set_layer_pixels(layer_id, decoded_rgb);
         }   break;
 
-        case DATA_TYPE_HALF: {
-            const PacketHalf *p = (const PacketHalf*)buf;
+        case DATA_TYPE_YCOCG: {
+            const PacketYCoCg *p = (const PacketYCoCg*)buf;
 
-            for(uint32_t x{}; x < 16u; ++x) {
-                for(uint32_t y{}; y < 16u; ++y) {
-                    uint32_t idx = y * 16u + x;
+            ycocg_decode(p->luma, p->co, p->cg, decoded_rgb);
 
-                    uint8_t r = (idx % 2u == 0u) ? ((p->data[idx * 3u / 2u + 0u] & 0xf0) >> 4) :  (p->data[idx * 3u / 2u + 0u] & 0x0f);
-                    uint8_t g = (idx % 2u == 0u) ?  (p->data[idx * 3u / 2u + 0u] & 0x0f)       : ((p->data[idx * 3u / 2u + 1u] & 0xf0) >> 4);
-                    uint8_t b = (idx % 2u == 0u) ? ((p->data[idx * 3u / 2u + 1u] & 0xf0) >> 4) :  (p->data[idx * 3u / 2u + 1u] & 0x0f);
+            compositor.set_layer_pixels(layer_id, decoded_rgb);
+        }   break;
 
-                    // Unpack from 4 bits to 8 bits
-                    led_matrix.set_pixel(x, y, r << 4, g << 4, b << 4);
-                }
+        case DATA_TYPE_YCOCG_QUANT: {
+            const PacketYCoCgQuant *p = (const PacketYCoCgQuant*)buf;
+
+            ycocg_decode_quant(p->luma, p->chroma, decoded_rgb);
+
+            compositor.set_layer_pixels(layer_id, decoded_rgb);
+        }   break;
+
+        case DATA_TYPE_LAYER_CONFIG: {
+            const PacketLayerConfig *p = (const PacketLayerConfig*)buf;
+
+            if(p->layer_id >= COMPOSITOR_MAX_LAYERS) {
+                printf("main(): layer_id must be lower than %u!\n", COMPOSITOR_MAX_LAYERS);
+
+                break;
             }
 
-            led_matrix.update_display();
+            client_layers[client_id] = p->layer_id;
+
+            compositor.set_layer_config(p->layer_id, p->z_order, p->opacity, LayerRect{ p->mask_x, p->mask_y, p->mask_w, p->mask_h });
         }   break;
 
         case DATA_TYPE_WRITE_FLASH: {
@@ -171,25 +200,25 @@ static void on_buffer_ready(const uint8_t *buf, WS2812B &led_matrix) {
         case DATA_TYPE_PLAY_FLASH: {
             const PacketPlayFlash *p = (const PacketPlayFlash*)buf;
 
-            begin_frame_idx_inclusive = p->begin_frame_idx_inclusive;
-            end_frame_idx_inclusive = p->end_frame_idx_inclusive;
-            time_interval_ms = p->time_interval_ms;
-
-            if(begin_frame_idx_inclusive > end_frame_idx_inclusive) {
+            // Validate before touching the playback of another client that may still be running
+            if(p->begin_frame_idx_inclusive > p->end_frame_idx_inclusive) {
                 printf("main(): begin_frame_idx_inclusive cannot be greater than end_frame_idx_inclusive!\n");
-                begin_frame_idx_inclusive = 0u;
-                end_frame_idx_inclusive = 0u;
-                
+
                 break;
             }
 
-            if(!add_repeating_timer_ms(-((int32_t)time_interval_ms), flash_player_timer_callback, &led_matrix, &flash_player_timer)) { 
-                printf("main(): Failed to create flash_player_timer!\n");
+            begin_frame_idx_inclusive = p->begin_frame_idx_inclusive;
+            end_frame_idx_inclusive = p->end_frame_idx_inclusive;
+            time_interval_ms = p->time_interval_ms;
 
-                break;
-            } else {
-                flash_player_running = true;
-            }
+            // Takes over the playback of another client if there is one
+            flash_player_client = client_id;
+            flash_player_layer = layer_id;
+            current_frame_id = begin_frame_idx_inclusive;
+
+            // Show the first frame right away
+            flash_player_next_frame_time = get_absolute_time();
+            flash_player_running = true;
         }   break;
 
         default:
@@ -223,7 +252,10 @@ int main() {
     led_matrix.fill(64, 64, 0);
     led_matrix.update_display();
 
-    TCPServer server{};
+    // Both are too large for the stack
+    static TCPServer server{};
+    static Compositor compositor{};
+
     if(!server.start(SEVER_PORT, SEVER_TIMEOUT_S)) {
         printf("main(): Failed to start the server. Retrying..\n");
 
@@ -244,12 +276,41 @@ int main() {
         cyw43_arch_poll();
         
         // Handle packets from the main thread to avoid problems (e.g. writing to flash)
-        const uint8_t *buf = server.get_ready_buffer();
-        if(buf != nullptr) {
-            on_buffer_ready(buf, led_matrix);
+        // At most one packet per client per refresh so a single client cannot starve the others
+        for(uint8_t client_id{}; client_id < TCP_SERVER_MAX_CLIENTS; ++client_id) {
+            if(server.pop_new_connection(client_id)) {
+                // Layers are never cleared here, they only change when a client draws to them or reconfigures them
+                client_layers[client_id] = DEFAULT_LAYER;
+
+                // A new client in the slot does not own the previous client's playback
+                if(flash_player_client == client_id) {
+                    flash_player_client = TCP_SERVER_MAX_CLIENTS;
+                }
+            }
+
+            const uint8_t *buf = server.get_ready_buffer(client_id);
+            if(buf != nullptr) {
+                on_buffer_ready(buf, client_id, compositor);
+                server.release_buffer(client_id);
+            }
         }
 
-        cyw43_arch_wait_for_work_until(make_timeout_time_ms(100));
+        flash_player_step(compositor);
+
+        // Blend all layers that changed into a single frame
+        compositor.compose(led_matrix);
+
+        // Clients may already have their next packets waiting
+        if(!server.has_ready_buffer()) {
+            absolute_time_t wait_until = make_timeout_time_ms(100);
+
+            // Wake up in time for the next flash frame
+            if(flash_player_running) {
+                wait_until = absolute_time_min(wait_until, flash_player_next_frame_time);
+            }
+
+            cyw43_arch_wait_for_work_until(wait_until);
+        }
     }
 
     cyw43_arch_deinit();
@@ -8,6 +8,9 @@ constexpr uint8_t DATA_TYPE_FULL = 0x01;
 constexpr uint8_t DATA_TYPE_HALF = 0x02;
 constexpr uint8_t DATA_TYPE_WRITE_FLASH = 0x03;
 constexpr uint8_t DATA_TYPE_PLAY_FLASH = 0x04;
+constexpr uint8_t DATA_TYPE_YCOCG = 0x05;
+constexpr uint8_t DATA_TYPE_YCOCG_QUANT = 0x06;
+constexpr uint8_t DATA_TYPE_LAYER_CONFIG = 0x07;
 
 // Immediately show a single frame of 8bpp (Full) RGB data.
 struct PacketFull {
@@ -21,6 +24,36 @@ struct PacketHalf {
     uint8_t data[16*16*3/2];
 };
 
+// Immediately show a single frame of YCoCg-R data with 2x2-subsampled chroma (see ycocg.hpp).
+// Half the size of PacketFull with far less banding than PacketHalf.
+struct PacketYCoCg {
+    uint8_t data_type = DATA_TYPE_YCOCG;
+    uint8_t luma[16*16];       // 8-bit Y per pixel
+    int8_t co[8*8];            // 8-bit Co per 2x2 block
+    int8_t cg[8*8];            // 8-bit Cg per 2x2 block
+};
+
+// Same as PacketYCoCg but with chroma quantised to 4 bits and packed as CoCg nibbles.
+struct PacketYCoCgQuant {
+    uint8_t data_type = DATA_TYPE_YCOCG_QUANT;
+    uint8_t luma[16*16];       // 8-bit Y per pixel
+    uint8_t chroma[8*8];       // 4-bit Co and 4-bit Cg per 2x2 block
+};
+
+// Moves the sending client to a layer and configures how that layer is blended with the other layers.
+// Frames sent by a client (Full, Half, YCoCg) only replace the layer the client is on.
+// Layers outlive connections, so a client that reconnects can get back to its layer by sending its layer_id again.
+struct PacketLayerConfig {
+    uint8_t data_type = DATA_TYPE_LAYER_CONFIG;
+    uint8_t layer_id;   // 0 - 7, every client starts on layer 0 which is shared by all clients that have not picked a layer
+    uint8_t z_order;    // Layers with higher z_order are drawn on top
+    uint8_t opacity;    // 0 - invisible, 255 - opaque
+    uint8_t mask_x;     // Only the masked rectangle of the layer is drawn and refreshed.
+    uint8_t mask_y;     // (mask_x:0, mask_y:0) is the lower-left corner.
+    uint8_t mask_w;     // A mask with mask_w or mask_h equal to 0 covers the whole display.
+    uint8_t mask_h;
+};
+
 // Writes a single frame of 8bpp (Full) RGB data.
 struct PacketWriteFlash {
     uint8_t data_type = DATA_TYPE_WRITE_FLASH;
@@ -28,8 +61,9 @@ struct PacketWriteFlash {
     uint8_t data[16*16*3];
 };
 
-// Plays the stored frames in flash.
-// The display will keep playing the frames until it receives a new packet.
+// Plays the stored frames in flash on the sending client's layer, other clients' layers are still blended on top or below.
+// The display will keep playing the frames until it receives a new packet from that client (or from a client that moved to that layer).
+// PacketLayerConfig does not stop the playback.
 // The TCP connection can be safely closed and it will keep playing the frames by itself.
 struct PacketPlayFlash {
     uint8_t data_type = DATA_TYPE_PLAY_FLASH;
@@ -44,6 +78,9 @@ static uint16_t get_data_type_size(uint8_t data_type) {
         case DATA_TYPE_HALF:        return sizeof(PacketHalf);
         case DATA_TYPE_WRITE_FLASH: return sizeof(PacketWriteFlash); 
         case DATA_TYPE_PLAY_FLASH:  return sizeof(PacketPlayFlash);      
+        case DATA_TYPE_YCOCG:       return sizeof(PacketYCoCg);
+        case DATA_TYPE_YCOCG_QUANT: return sizeof(PacketYCoCgQuant);
+        case DATA_TYPE_LAYER_CONFIG: return sizeof(PacketLayerConfig);
         default:
             printf("get_data_type_size(uint8_t data_type): Invalid packet data_type!");
             return 0u;
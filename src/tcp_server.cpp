@@ -17,8 +17,8 @@ bool TCPServer::start(uint16_t port, uint8_t _timeout_time_s) {
         printf("TCPServer::start(uint16_t port): Failed to bind to port: %u\n", port);
         return false;
     }
-    
-    server_pcb = tcp_listen_with_backlog(pcb, 1);
+
+    server_pcb = tcp_listen_with_backlog(pcb, TCP_SERVER_MAX_CLIENTS);
     if (!server_pcb) {
         printf("TCPServer::start(uint16_t port): Failed to listen for incoming clients.\n");
 
@@ -29,6 +29,10 @@ bool TCPServer::start(uint16_t port, uint8_t _timeout_time_s) {
 
     timeout_time_s = _timeout_time_s;
 
+    for(Client &client : clients) {
+        client.server = this;
+    }
+
     tcp_arg(server_pcb, this);
     tcp_accept(server_pcb, TCPServer::server_connect_client);
 
@@ -38,19 +42,118 @@ void TCPServer::stop() {
     return server_close(this);
 }
 
-const uint8_t *TCPServer::get_ready_buffer() {
-    if(is_buffer_ready) {
-        is_buffer_ready = false;
-        
-        return in_buffer;
+bool TCPServer::is_connected() const {
+    for(const Client &client : clients) {
+        if(client.pcb != nullptr) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TCPServer::pop_new_connection(uint8_t client_id) {
+    if(clients[client_id].is_new) {
+        clients[client_id].is_new = false;
+
+        return true;
+    } else {
+        return false;
+    }
+}
+
+const uint8_t *TCPServer::get_ready_buffer(uint8_t client_id) const {
+    if(clients[client_id].is_buffer_ready) {
+        return clients[client_id].in_buffer;
     } else {
         return nullptr;
     }
 }
 
-err_t TCPServer::server_send_data(void *arg, tcp_pcb *tpcb, const void *data, uint16_t data_size) {
-    TCPServer *state = (TCPServer*)arg;
+bool TCPServer::has_ready_buffer() const {
+    for(const Client &client : clients) {
+        if(client.is_buffer_ready) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TCPServer::release_buffer(uint8_t client_id) {
+    Client *client = &clients[client_id];
+    if(!client->is_buffer_ready) {
+        return;
+    }
+
+    client->is_buffer_ready = false;
+
+    cyw43_arch_lwip_begin();
+
+    if(client->pcb != nullptr) {
+        // Respond with "ACK" message only once the packet was handled.
+        // Clients wait for it before sending more, which throttles each of them to the display's pace.
+        const char* ack_message = "ACK";
+        server_send_data(client, client->pcb, ack_message, strlen(ack_message) + 1u);
+
+        // Data may have arrived while the packet was being handled
+        client_consume(client);
+
+        tcp_output(client->pcb);
+    } else {
+        // The client has already disconnected, hand out the rest of the packets it managed to send
+        client_consume(client);
+
+        if(!client->is_buffer_ready) {
+            client_drop_data(client);
+        }
+    }
 
+    cyw43_arch_lwip_end();
+}
+
+// Copies pending data into in_buffer until a whole packet is received.
+// The TCP receive window is only reopened for the copied bytes, so a client that sends faster than its packets are handled gets slowed down by TCP itself.
+void TCPServer::client_consume(Client *client) {
+    while(client->pending != nullptr && !client->is_buffer_ready) {
+        if(client->in_received_count == 0u) {
+            // Read the data_type byte first to know the packet size
+            pbuf_copy_partial(client->pending, client->in_buffer, 1u, 0u);
+            client->pending = pbuf_free_header(client->pending, 1u);
+            if(client->pcb != nullptr) {
+                tcp_recved(client->pcb, 1u);
+            }
+
+            if(get_data_type_size(client->in_buffer[0]) != 0u) {
+                client->in_received_count = 1u;
+            }
+
+            continue;
+        }
+
+        uint16_t packet_size = get_data_type_size(client->in_buffer[0]);
+        uint16_t bytes_missing = packet_size - client->in_received_count;
+        uint16_t bytes_to_copy = (client->pending->tot_len < bytes_missing) ? client->pending->tot_len : bytes_missing;
+
+        uint16_t bytes_read = pbuf_copy_partial(client->pending, (void*)(client->in_buffer + client->in_received_count), bytes_to_copy, 0u);
+        client->pending = pbuf_free_header(client->pending, bytes_read);
+        if(client->pcb != nullptr) {
+            tcp_recved(client->pcb, bytes_read);
+        }
+
+        //printf("Server read: %u bytes\n", (uint32_t)bytes_read);
+
+        client->in_received_count += bytes_read;
+
+        // Whole incoming packet received
+        if(client->in_received_count == packet_size) {
+            client->in_received_count = 0u;
+            client->is_buffer_ready = true;
+        }
+    }
+}
+
+err_t TCPServer::server_send_data(void *arg, tcp_pcb *tpcb, const void *data, uint16_t data_size) {
     cyw43_arch_lwip_check();
 
     if (tcp_write(tpcb, data, data_size, TCP_WRITE_FLAG_COPY) != ERR_OK) {
@@ -62,7 +165,7 @@ err_t TCPServer::server_send_data(void *arg, tcp_pcb *tpcb, const void *data, ui
 }
 
 err_t TCPServer::server_recv(void *arg, tcp_pcb *tpcb, pbuf *p, err_t err) {
-    TCPServer *state = (TCPServer*)arg;
+    Client *client = (Client*)arg;
     if (!p) {
         server_disconnect_client(arg);
         return ERR_OK; // Safely handled disconnect
@@ -70,42 +173,31 @@ err_t TCPServer::server_recv(void *arg, tcp_pcb *tpcb, pbuf *p, err_t err) {
 
     cyw43_arch_lwip_check();
 
-    if (p->tot_len > 0u) {
-        uint16_t bytes_read = pbuf_copy_partial(p, (void*)(state->in_buffer + state->in_received_count), p->tot_len, 0);
+    if (p->tot_len == 0u) {
         pbuf_free(p);
+        return ERR_OK;
+    }
 
-        if(bytes_read == 0u) {
-            printf("TCPServer::server_recv(void *arg, tcp_pcb *tpcb, pbuf *p, err_t err): Server failed to read bytes!\n");
-
+    if (client->pending != nullptr) {
+        // Refuse the data while too much is already waiting, lwIP keeps it and delivers it again later
+        if (client->pending->tot_len + p->tot_len > TCP_SERVER_MAX_PENDING_BYTES) {
             return ERR_MEM;
         }
-        
-        //printf("Server read: %u bytes, err: %d\n", (uint32_t)bytes_read, err);
-
-        state->in_received_count += bytes_read;
 
-        tcp_recved(tpcb, bytes_read);
-
-        // Whole incoming packet received
-        if(state->in_received_count == get_data_type_size(state->in_buffer[0])) {
-            state->in_received_count = 0u;
-            state->is_buffer_ready = true;
-
-            // Respond with "ACK" message
-            const char* ack_message = "ACK";
-            return server_send_data(arg, state->client_pcb, ack_message, strlen(ack_message) + 1u);
-        }
+        pbuf_cat(client->pending, p);
     } else {
-        pbuf_free(p);
+        client->pending = p;
     }
 
+    client_consume(client);
+
     return ERR_OK;
 }
 
 err_t TCPServer::server_poll(void *arg, tcp_pcb *tpcb) {
-    TCPServer *state = (TCPServer*)arg;
+    Client *client = (Client*)arg;
 
-    printf("TCPServer::server_poll(void *arg, tcp_pcb *tpcb): No communication with client for more than %u seconds!\n", state->timeout_time_s);
+    printf("TCPServer::server_poll(void *arg, tcp_pcb *tpcb): No communication with client for more than %u seconds!\n", client->server->timeout_time_s);
 
     server_disconnect_client(arg);
 
@@ -115,7 +207,10 @@ err_t TCPServer::server_poll(void *arg, tcp_pcb *tpcb) {
 void TCPServer::server_close(void *arg) {
     TCPServer *state = (TCPServer*)arg;
 
-    server_disconnect_client(arg);
+    for(Client &client : state->clients) {
+        server_disconnect_client(&client);
+        client_drop_data(&client);
+    }
 
     if (state->server_pcb) {
         tcp_arg(state->server_pcb, nullptr);
@@ -126,14 +221,22 @@ void TCPServer::server_close(void *arg) {
 }
 
 void TCPServer::server_err(void *arg, err_t err) {
+    Client *client = (Client*)arg;
+    if(client == nullptr) {
+        return;
+    }
+
+    // lwIP has already freed the pcb by the time this is called
+    client->pcb = nullptr;
+    server_forget_client(client);
+
     // Failsafe
     if(err == ERR_CLSD || err == ERR_ABRT || err == ERR_RST || err == ERR_TIMEOUT || err == ERR_RTE) {
-        server_disconnect_client(arg);  // Safely handled disconnect
-        return; 
+        return; // Safely handled disconnect
     }
-    
+
     printf("TCPServer::server_err(void *arg, err_t err): code:%d\n", (int)err);
-    server_close(arg);
+    server_close(client->server);
 }
 
 err_t TCPServer::server_connect_client(void *arg, tcp_pcb *client_pcb, err_t err) {
@@ -143,38 +246,76 @@ err_t TCPServer::server_connect_client(void *arg, tcp_pcb *client_pcb, err_t err
         return ERR_VAL;
     }
 
-    state->client_pcb = client_pcb;
-    
-    tcp_arg(state->client_pcb, state);
-    tcp_recv(state->client_pcb, TCPServer::server_recv);
-    tcp_poll(state->client_pcb, TCPServer::server_poll, state->timeout_time_s * 2u);
-    tcp_err(state->client_pcb, TCPServer::server_err);
+    // A slot is only free once the packets of its previous client were handled
+    Client *client = nullptr;
+    for(Client &c : state->clients) {
+        if(c.pcb == nullptr && !c.is_buffer_ready) {
+            client = &c;
+            break;
+        }
+    }
+
+    if(client == nullptr) {
+        printf("TCPServer::server_connect_client(void *arg, tcp_pcb *client_pcb, err_t err): All %u client slots are taken!\n", TCP_SERVER_MAX_CLIENTS);
 
-    printf("Client connected\n");
+        tcp_abort(client_pcb);
+        return ERR_ABRT;
+    }
+
+    client->pcb = client_pcb;
+    client->is_new = true;
+
+    tcp_arg(client->pcb, client);
+    tcp_recv(client->pcb, TCPServer::server_recv);
+    tcp_poll(client->pcb, TCPServer::server_poll, state->timeout_time_s * 2u);
+    tcp_err(client->pcb, TCPServer::server_err);
+
+    printf("Client %u connected\n", (uint32_t)(client - state->clients));
 
     cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 1);
 
     return ERR_OK;
 }
 void TCPServer::server_disconnect_client(void *arg) {
-    TCPServer *state = (TCPServer*)arg;
-    if(state->client_pcb == nullptr) {
+    Client *client = (Client*)arg;
+    if(client->pcb == nullptr) {
         return;
     }
-    
-    tcp_arg(state->client_pcb, nullptr);
-    tcp_poll(state->client_pcb, nullptr, 0);
-    tcp_recv(state->client_pcb, nullptr);
-    tcp_err(state->client_pcb, nullptr);
 
-    if (tcp_close(state->client_pcb) != ERR_OK) {
+    tcp_arg(client->pcb, nullptr);
+    tcp_poll(client->pcb, nullptr, 0);
+    tcp_recv(client->pcb, nullptr);
+    tcp_err(client->pcb, nullptr);
+
+    if (tcp_close(client->pcb) != ERR_OK) {
         printf("TCPServer::server_disconnect_client(void *arg): tcp_close failed, calling tcp_abort\n");
-        tcp_abort(state->client_pcb);
+        tcp_abort(client->pcb);
+    }
+
+    client->pcb = nullptr;
+
+    server_forget_client(client);
+}
+void TCPServer::server_forget_client(Client *client) {
+    // Keep whole packets that were received before the disconnect, they are still handled (without an "ACK")
+    client_consume(client);
+
+    if(!client->is_buffer_ready) {
+        client_drop_data(client);
     }
 
-    state->client_pcb = nullptr;
+    printf("Client %u disconnected\n", (uint32_t)(client - client->server->clients));
 
-    printf("Client disconnected\n");
+    if(!client->server->is_connected()) {
+        cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 0);
+    }
+}
+void TCPServer::client_drop_data(Client *client) {
+    if(client->pending != nullptr) {
+        pbuf_free(client->pending);
+        client->pending = nullptr;
+    }
 
-    cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 0);
-}
\ No newline at end of file
+    client->in_received_count = 0u;
+    client->is_buffer_ready = false;
+}
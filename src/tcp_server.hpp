@@ -7,25 +7,54 @@
 #include <lwip/pbuf.h>
 #include <lwip/tcp.h>
 
+constexpr uint8_t TCP_SERVER_MAX_CLIENTS = 4u;
+
+// Received data held back per client before the server stops accepting more (see TCPServer::server_recv).
+// Keeps one chatty client from using up the whole lwIP pbuf pool.
+constexpr uint16_t TCP_SERVER_MAX_PENDING_BYTES = 2u * TCP_MSS;
+
 class TCPServer {
 public:
     bool start(uint16_t port, uint8_t _timeout_time_s);
     void stop();
 
-    inline bool is_connected() const { return client_pcb != nullptr; };
+    bool is_connected() const;
     inline bool is_running() const { return server_pcb != nullptr; };
 
-    const uint8_t *get_ready_buffer();
+    // Returns true once after a new client has connected to the client_id slot.
+    bool pop_new_connection(uint8_t client_id);
+
+    // Returns the client's whole received packet or nullptr.
+    // The buffer stays valid until release_buffer(client_id) is called.
+    const uint8_t *get_ready_buffer(uint8_t client_id) const;
+    bool has_ready_buffer() const;
+
+    // Responds with "ACK" and lets the client's next packet in.
+    // Packets received before a client disconnected are still handed out, but the slot stays taken until they are released.
+    void release_buffer(uint8_t client_id);
 
 private:
+    struct Client {
+        TCPServer *server{};
+        tcp_pcb *pcb{};
+
+        pbuf *pending{}; // Received data that was not copied into in_buffer yet
+
+        uint16_t in_received_count{};
+        uint8_t in_buffer[2048];
+
+        bool is_buffer_ready{};
+        bool is_new{};
+    };
+
     uint8_t timeout_time_s{};
 
-    tcp_pcb *server_pcb{}, *client_pcb{};
+    tcp_pcb *server_pcb{};
 
-    uint16_t in_received_count{};
-    uint8_t in_buffer[2048];
+    Client clients[TCP_SERVER_MAX_CLIENTS]{};
 
-    bool is_buffer_ready{};
+    static void client_consume(Client *client);
+    static void client_drop_data(Client *client);
 
     static err_t server_send_data(void *arg, tcp_pcb *tpcb, const void *data, uint16_t data_size);
     static err_t server_recv(void *arg, tcp_pcb *tpcb, pbuf *p, err_t err);
@@ -36,6 +65,7 @@ private:
 
     static err_t server_connect_client(void *arg, tcp_pcb *client_pcb, err_t err);
     static void server_disconnect_client(void *arg);
+    static void server_forget_client(Client *client);
 };
 
 #endif
\ No newline at end of file
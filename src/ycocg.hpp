@@ -0,0 +1,194 @@
+#ifndef _YCOCG_HPP
+#define _YCOCG_HPP
+
+#include <cstdint>
+
+// YCoCg-R colour transform with 2x2 chroma subsampling.
+// https://en.wikipedia.org/wiki/YCoCg#The_lifting-based_YCoCg-R_variation
+//
+// Luma (Y) is kept for every pixel, chroma (Co, Cg) is stored once per 2x2 block of pixels
+// and bilinearly interpolated back to full resolution by the decoder.
+// The decoder is integer-only (additions, small multiplies and shifts) so it is cheap to run on the Pico.
+// The encoder is meant to run on the host (controller) and does all of the heavy lifting.
+
+constexpr uint32_t YCOCG_WIDTH = 16u;
+constexpr uint32_t YCOCG_HEIGHT = 16u;
+constexpr uint32_t YCOCG_LUMA_COUNT = YCOCG_WIDTH * YCOCG_HEIGHT;
+constexpr uint32_t YCOCG_CHROMA_COUNT = (YCOCG_WIDTH / 2u) * (YCOCG_HEIGHT / 2u);
+
+// Co and Cg are 9-bit signed values (-255..255), they are stored as (value >> shift).
+constexpr uint32_t YCOCG_CHROMA_SHIFT_8BIT = 1u; // 8-bit signed chroma samples
+constexpr uint32_t YCOCG_CHROMA_SHIFT_4BIT = 5u; // 4-bit signed chroma samples (quantised)
+
+static inline uint8_t ycocg_clamp_u8(int32_t v) {
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline int32_t ycocg_clamp(int32_t v, int32_t lo, int32_t hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// Chroma of pixel (x, y) bilinearly interpolated from the four nearest block centres.
+// Weights are 9/16, 3/16, 3/16 and 1/16 so it only needs integer multiplies and a shift.
+static inline int32_t ycocg_upsample(const int16_t *plane, uint32_t x, uint32_t y) {
+    constexpr uint32_t blocks_x = YCOCG_WIDTH / 2u;
+    constexpr uint32_t blocks_y = YCOCG_HEIGHT / 2u;
+
+    uint32_t bx = x / 2u, by = y / 2u;
+
+    // Neighbouring block on the side of the pixel, clamped at the edges
+    uint32_t nx = (x % 2u == 0u) ? (bx > 0u ? bx - 1u : bx) : (bx + 1u < blocks_x ? bx + 1u : bx);
+    uint32_t ny = (y % 2u == 0u) ? (by > 0u ? by - 1u : by) : (by + 1u < blocks_y ? by + 1u : by);
+
+    int32_t sum =
+        9 * plane[by * blocks_x + bx] +
+        3 * plane[by * blocks_x + nx] +
+        3 * plane[ny * blocks_x + bx] +
+            plane[ny * blocks_x + nx];
+
+    return (sum + 8) >> 4;
+}
+
+// Sign-extends the high (CoCg[7:4]) or low (CoCg[3:0]) nibble of a packed 4-bit chroma byte.
+static inline int32_t ycocg_unpack_nibble(uint8_t packed, bool high) {
+    int32_t v = high ? (packed >> 4) : (packed & 0x0f);
+    return (v ^ 0x08) - 0x08;
+}
+
+// Reconstructs a single RGB pixel from its luma and chroma.
+static inline void ycocg_decode_pixel(int32_t y, int32_t co, int32_t cg, uint8_t *rgb) {
+    int32_t t = y - (cg >> 1);
+    int32_t g = cg + t;
+    int32_t b = t - (co >> 1);
+    int32_t r = b + co;
+
+    rgb[0] = ycocg_clamp_u8(r);
+    rgb[1] = ycocg_clamp_u8(g);
+    rgb[2] = ycocg_clamp_u8(b);
+}
+
+// Decodes luma and dequantised chroma planes into row-major 8bpp RGB (16*16*3 bytes).
+static inline void ycocg_decode_planes(const uint8_t *luma, const int16_t *co, const int16_t *cg, uint8_t *rgb_out) {
+    for(uint32_t y{}; y < YCOCG_HEIGHT; ++y) {
+        for(uint32_t x{}; x < YCOCG_WIDTH; ++x) {
+            uint32_t idx = y * YCOCG_WIDTH + x;
+
+            ycocg_decode_pixel(luma[idx], ycocg_upsample(co, x, y), ycocg_upsample(cg, x, y), &rgb_out[idx * 3u]);
+        }
+    }
+}
+
+// Decodes 8-bit chroma into row-major 8bpp RGB (16*16*3 bytes).
+static inline void ycocg_decode(const uint8_t *luma, const int8_t *co, const int8_t *cg, uint8_t *rgb_out) {
+    int16_t co_plane[YCOCG_CHROMA_COUNT], cg_plane[YCOCG_CHROMA_COUNT];
+
+    for(uint32_t i{}; i < YCOCG_CHROMA_COUNT; ++i) {
+        co_plane[i] = (int16_t)(co[i] * (1 << YCOCG_CHROMA_SHIFT_8BIT));
+        cg_plane[i] = (int16_t)(cg[i] * (1 << YCOCG_CHROMA_SHIFT_8BIT));
+    }
+
+    ycocg_decode_planes(luma, co_plane, cg_plane, rgb_out);
+}
+
+// Decodes nibble-packed 4-bit chroma (CoCg per byte) into row-major 8bpp RGB (16*16*3 bytes).
+static inline void ycocg_decode_quant(const uint8_t *luma, const uint8_t *chroma, uint8_t *rgb_out) {
+    int16_t co_plane[YCOCG_CHROMA_COUNT], cg_plane[YCOCG_CHROMA_COUNT];
+
+    for(uint32_t i{}; i < YCOCG_CHROMA_COUNT; ++i) {
+        co_plane[i] = (int16_t)(ycocg_unpack_nibble(chroma[i], true) * (1 << YCOCG_CHROMA_SHIFT_4BIT));
+        cg_plane[i] = (int16_t)(ycocg_unpack_nibble(chroma[i], false) * (1 << YCOCG_CHROMA_SHIFT_4BIT));
+    }
+
+    ycocg_decode_planes(luma, co_plane, cg_plane, rgb_out);
+}
+
+// Host-side encoder.
+// Chroma is computed from the average colour of every 2x2 block and quantised to (value >> chroma_shift).
+// Luma is then picked per pixel so that the decoded RGB (with the quantised, interpolated chroma) is as close as possible to the source.
+// Outputs chroma samples as signed integers in the range of the chosen shift, packing them is up to the caller.
+static inline void ycocg_encode(const uint8_t *rgb_in, uint32_t chroma_shift, uint8_t *luma_out, int32_t *co_out, int32_t *cg_out) {
+    // Range of a (9 - chroma_shift)-bit signed integer
+    const int32_t q_lo = -(1 << (8u - chroma_shift));
+    const int32_t q_hi = (1 << (8u - chroma_shift)) - 1;
+
+    // Dequantised planes exactly as the decoder will see them
+    int16_t co_plane[YCOCG_CHROMA_COUNT], cg_plane[YCOCG_CHROMA_COUNT];
+
+    for(uint32_t by{}; by < YCOCG_HEIGHT / 2u; ++by) {
+        for(uint32_t bx{}; bx < YCOCG_WIDTH / 2u; ++bx) {
+            int32_t sum[3]{};
+
+            for(uint32_t i{}; i < 4u; ++i) {
+                uint32_t idx = (by * 2u + i / 2u) * YCOCG_WIDTH + (bx * 2u + i % 2u);
+
+                sum[0] += rgb_in[idx * 3u + 0u];
+                sum[1] += rgb_in[idx * 3u + 1u];
+                sum[2] += rgb_in[idx * 3u + 2u];
+            }
+
+            // Average block colour scaled by 4 to keep two fractional bits
+            int32_t co4 = sum[0] - sum[2];
+            int32_t cg4 = sum[1] - (sum[0] + sum[2]) / 2;
+
+            // Round to the nearest quantisation step
+            int32_t step4 = 4 << chroma_shift;
+            int32_t co_q = ycocg_clamp((co4 + (co4 < 0 ? -step4 / 2 : step4 / 2)) / step4, q_lo, q_hi);
+            int32_t cg_q = ycocg_clamp((cg4 + (cg4 < 0 ? -step4 / 2 : step4 / 2)) / step4, q_lo, q_hi);
+
+            uint32_t c = by * (YCOCG_WIDTH / 2u) + bx;
+            co_out[c] = co_q;
+            cg_out[c] = cg_q;
+            co_plane[c] = (int16_t)(co_q * (1 << chroma_shift));
+            cg_plane[c] = (int16_t)(cg_q * (1 << chroma_shift));
+        }
+    }
+
+    for(uint32_t y{}; y < YCOCG_HEIGHT; ++y) {
+        for(uint32_t x{}; x < YCOCG_WIDTH; ++x) {
+            uint32_t idx = y * YCOCG_WIDTH + x;
+
+            int32_t co = ycocg_upsample(co_plane, x, y);
+            int32_t cg = ycocg_upsample(cg_plane, x, y);
+
+            // Offsets the decoder will add to Y for each channel
+            int32_t off_g = cg - (cg >> 1);
+            int32_t off_b = -(cg >> 1) - (co >> 1);
+            int32_t off_r = off_b + co;
+
+            int32_t target =
+                ((int32_t)rgb_in[idx * 3u + 0u] - off_r) +
+                ((int32_t)rgb_in[idx * 3u + 1u] - off_g) +
+                ((int32_t)rgb_in[idx * 3u + 2u] - off_b);
+
+            // Least-squares luma, rounded to the nearest integer
+            int32_t lum = (target >= 0) ? (target + 1) / 3 : -((-target + 1) / 3);
+
+            luma_out[idx] = ycocg_clamp_u8(lum);
+        }
+    }
+}
+
+// Encodes row-major 8bpp RGB into full luma and 8-bit chroma.
+static inline void ycocg_encode_8bit(const uint8_t *rgb_in, uint8_t *luma_out, int8_t *co_out, int8_t *cg_out) {
+    int32_t co[YCOCG_CHROMA_COUNT], cg[YCOCG_CHROMA_COUNT];
+
+    ycocg_encode(rgb_in, YCOCG_CHROMA_SHIFT_8BIT, luma_out, co, cg);
+
+    for(uint32_t i{}; i < YCOCG_CHROMA_COUNT; ++i) {
+        co_out[i] = (int8_t)co[i];
+        cg_out[i] = (int8_t)cg[i];
+    }
+}
+
+// Encodes row-major 8bpp RGB into full luma and nibble-packed 4-bit chroma (CoCg per byte).
+static inline void ycocg_encode_quant(const uint8_t *rgb_in, uint8_t *luma_out, uint8_t *chroma_out) {
+    int32_t co[YCOCG_CHROMA_COUNT], cg[YCOCG_CHROMA_COUNT];
+
+    ycocg_encode(rgb_in, YCOCG_CHROMA_SHIFT_4BIT, luma_out, co, cg);
+
+    for(uint32_t i{}; i < YCOCG_CHROMA_COUNT; ++i) {
+        chroma_out[i] = (uint8_t)(((co[i] & 0x0f) << 4) | (cg[i] & 0x0f));
+    }
+}
+
+#endif